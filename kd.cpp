@@ -6,6 +6,29 @@
 #include <queue>
 #include <limits>
 #include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#define fsync _commit
+#endif
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
 
 using namespace std;
 
@@ -22,10 +45,10 @@ public:
     vector<pair<string, int>> resources;
     int needValue;
 
-    Camp() : number(0), name(""), address(""), contact("") {} // default constructor
+    Camp() : number(0), name(""), address(""), contact(""), needValue(0) {} // default constructor
 
     Camp(int number, const string& name, const string& address, const string& contact)
-        : number(number), name(name), address(address), contact(contact) {}
+        : number(number), name(name), address(address), contact(contact), needValue(0) {}
 };
 
 class Node {
@@ -38,24 +61,355 @@ public:
     Node(int id) : id(id), dist(numeric_limits<int>::max()), visited(false) {}
 };
 
+// Append-only journal of graph edits. Records are handed to a background
+// writer thread which group-commits them (one write + one fsync per batch),
+// so the menus never wait on the disk. Every checkpointInterval records a
+// snapshot of the whole graph is written and the journal is truncated, so
+// recovery only replays the tail written since the last checkpoint.
+class Journal {
+public:
+    Journal(const string& journalPath, const string& checkpointPath, size_t checkpointInterval = 256)
+        : journalPath(journalPath), checkpointPath(checkpointPath), checkpointInterval(checkpointInterval) {}
+
+    ~Journal() {
+        {
+            lock_guard<mutex> lock(mtx);
+            stopping = true;
+        }
+        pendingCv.notify_all();
+        if (writer.joinable()) {
+            writer.join();
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    // Loads the last checkpoint and the valid journal records written after it.
+    // An unterminated last record (crash mid-write) is cut off; a bad record
+    // anywhere else means the journal is damaged and recovery stops.
+    void recover(string& snapshot, vector<string>& tail) {
+        uint64_t checkpointSeq = 0;
+        ifstream checkpointFile(checkpointPath, ios::binary);
+        if (checkpointFile) {
+            string header;
+            checkpointFile >> header >> checkpointSeq;
+            checkpointFile.get();
+            if (header != "checkpoint") {
+                throw runtime_error("Corrupt checkpoint file: " + checkpointPath);
+            }
+            stringstream rest;
+            rest << checkpointFile.rdbuf();
+            snapshot = rest.str();
+        }
+        nextSeq = checkpointSeq + 1;
+
+        ifstream journalFile(journalPath, ios::binary);
+        if (!journalFile) {
+            return;
+        }
+        string line;
+        streamoff goodOffset = 0;
+        bool torn = false;
+        while (getline(journalFile, line)) {
+            if (journalFile.eof()) {
+                torn = true; // last line has no newline, so it never fully reached the disk
+                break;
+            }
+            uint64_t seq;
+            string payload;
+            if (!parseRecord(line, seq, payload)) {
+                throw runtime_error("Corrupt journal record at byte " + to_string(goodOffset) + " of " + journalPath);
+            }
+            goodOffset = journalFile.tellg();
+            if (seq > checkpointSeq) {
+                tail.push_back(payload);
+                nextSeq = seq + 1;
+            }
+        }
+        journalFile.close();
+        if (torn && truncate(journalPath.c_str(), goodOffset) != 0) {
+            throw runtime_error("Unable to trim journal: " + journalPath);
+        }
+    }
+
+    void start() {
+        fd = open(journalPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_BINARY, 0644);
+        if (fd < 0) {
+            throw runtime_error("Unable to open journal: " + journalPath);
+        }
+        durableSeq = nextSeq - 1; // everything recovered is already on disk
+        writer = thread(&Journal::writerLoop, this);
+    }
+
+    // Queues a record and returns its sequence number without touching the disk.
+    uint64_t append(const string& payload) {
+        uint64_t seq;
+        {
+            lock_guard<mutex> lock(mtx);
+            seq = nextSeq++;
+            pending.push_back({false, seq, formatRecord(seq, payload)});
+            itemsQueued++;
+            recordsSinceCheckpoint++;
+        }
+        pendingCv.notify_one();
+        return seq;
+    }
+
+    // Also true while the journal is broken, since only a checkpoint can
+    // make the lost records durable again.
+    bool checkpointDue() {
+        lock_guard<mutex> lock(mtx);
+        return recordsSinceCheckpoint >= checkpointInterval || journalBroken;
+    }
+
+    // Queues a snapshot covering every record appended so far. The writer
+    // persists it after those records and then empties the journal.
+    void checkpoint(const string& snapshot) {
+        {
+            lock_guard<mutex> lock(mtx);
+            pending.push_back({true, nextSeq - 1, snapshot});
+            itemsQueued++;
+            recordsSinceCheckpoint = 0;
+        }
+        pendingCv.notify_one();
+    }
+
+    // Blocks until everything queued so far has been written. Returns false if
+    // a write failed and no checkpoint has covered it since, i.e. edits are lost.
+    bool sync() {
+        unique_lock<mutex> lock(mtx);
+        size_t target = itemsQueued;
+        durableCv.wait(lock, [&] { return itemsDone >= target; });
+        return !writerFailed && durableSeq >= nextSeq - 1;
+    }
+
+private:
+    struct PendingItem {
+        bool isCheckpoint;
+        uint64_t seq;
+        string data;
+    };
+
+    string journalPath;
+    string checkpointPath;
+    size_t checkpointInterval;
+    int fd = -1;
+    thread writer;
+
+    mutex mtx;
+    condition_variable pendingCv;
+    condition_variable durableCv;
+    deque<PendingItem> pending;
+    uint64_t nextSeq = 1;
+    uint64_t durableSeq = 0; // frozen while a write failure is uncovered
+    size_t itemsQueued = 0;
+    size_t itemsDone = 0;
+    size_t recordsSinceCheckpoint = 0;
+    bool stopping = false;
+    bool writerFailed = false;
+    atomic<bool> journalBroken{false}; // set by the writer when a batch is lost
+
+    static uint64_t checksum(const string& data) {
+        uint64_t hash = 14695981039346656037ULL; // FNV-1a
+        for (unsigned char c : data) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    static string formatRecord(uint64_t seq, const string& payload) {
+        string body = to_string(seq) + " " + payload;
+        return to_string(checksum(body)) + " " + body + "\n";
+    }
+
+    static bool parseRecord(const string& line, uint64_t& seq, string& payload) {
+        size_t firstSpace = line.find(' ');
+        if (firstSpace == string::npos) {
+            return false;
+        }
+        string body = line.substr(firstSpace + 1);
+        size_t secondSpace = body.find(' ');
+        if (secondSpace == string::npos) {
+            return false;
+        }
+        try {
+            if (stoull(line.substr(0, firstSpace)) != checksum(body)) {
+                return false;
+            }
+            seq = stoull(body.substr(0, secondSpace));
+        } catch (const exception&) {
+            return false;
+        }
+        payload = body.substr(secondSpace + 1);
+        return true;
+    }
+
+    static bool writeAll(int fileFd, const string& data) {
+        size_t written = 0;
+        while (written < data.size()) {
+            ssize_t n = write(fileFd, data.data() + written, data.size() - written);
+            if (n < 0) {
+                return false;
+            }
+            written += n;
+        }
+        return true;
+    }
+
+    // A failed batch is cut back off the journal so no fragment is left for
+    // later records to land behind. Records after a lost batch would replay
+    // against the wrong state, so nothing more is appended until a checkpoint
+    // has covered the loss.
+    bool flushBatch(string& batch) {
+        if (batch.empty()) {
+            return true;
+        }
+        bool ok = false;
+        if (!journalBroken) {
+            off_t start = lseek(fd, 0, SEEK_END);
+            ok = start >= 0 && writeAll(fd, batch) && fsync(fd) == 0;
+            if (!ok) {
+                if (start >= 0 && ftruncate(fd, start) == 0) {
+                    fsync(fd);
+                }
+                journalBroken = true;
+            }
+        }
+        batch.clear();
+        return ok;
+    }
+
+    // Written to a temporary file and renamed into place, so a crash leaves
+    // either the old checkpoint or the new one, never a partial file.
+    bool writeCheckpoint(const PendingItem& item) {
+        string tmpPath = checkpointPath + ".tmp";
+        int tmpFd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+        if (tmpFd < 0) {
+            return false;
+        }
+        string header = "checkpoint " + to_string(item.seq) + "\n";
+        bool ok = writeAll(tmpFd, header) && writeAll(tmpFd, item.data) && fsync(tmpFd) == 0;
+        close(tmpFd);
+        // The rename must be durable before the journal is emptied, otherwise a
+        // power loss could bring back the old checkpoint with no journal behind it.
+        if (!ok || !replaceFile(tmpPath, checkpointPath)) {
+            return false;
+        }
+        return ftruncate(fd, 0) == 0 && fsync(fd) == 0;
+    }
+
+    // Durably moves from over to, replacing any existing file.
+    static bool replaceFile(const string& from, const string& to) {
+#ifdef _WIN32
+        return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        return rename(from.c_str(), to.c_str()) == 0 && syncParentDirectory(to);
+#endif
+    }
+
+#ifndef _WIN32
+    static bool syncParentDirectory(const string& path) {
+        size_t slash = path.find_last_of('/');
+        string dir = slash == string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+        int dirFd = open(dir.c_str(), O_RDONLY);
+        if (dirFd < 0) {
+            return false;
+        }
+        bool ok = fsync(dirFd) == 0;
+        close(dirFd);
+        return ok;
+    }
+#endif
+
+    void writerLoop() {
+        unique_lock<mutex> lock(mtx);
+        while (true) {
+            pendingCv.wait(lock, [&] { return stopping || !pending.empty(); });
+            if (pending.empty()) {
+                break;
+            }
+            if (!stopping) {
+                // Short commit window so edits arriving together share one fsync.
+                pendingCv.wait_for(lock, chrono::milliseconds(2), [&] { return stopping; });
+            }
+            deque<PendingItem> items;
+            items.swap(pending);
+            lock.unlock();
+
+            bool failed = false;
+            bool checkpointed = false;
+            string batch;
+            uint64_t lastSeq = 0;
+            for (const PendingItem& item : items) {
+                if (item.isCheckpoint) {
+                    failed = !flushBatch(batch) || failed;
+                    // The snapshot covers every record before it, lost ones included.
+                    if (writeCheckpoint(item)) {
+                        journalBroken = false;
+                        failed = false;
+                        checkpointed = true;
+                    } else {
+                        failed = true;
+                    }
+                } else {
+                    batch += item.data;
+                }
+                lastSeq = max(lastSeq, item.seq);
+            }
+            failed = !flushBatch(batch) || failed;
+
+            lock.lock();
+            if (failed) {
+                if (!writerFailed) {
+                    cerr << "Warning: journal write failed, recent edits are not saved!\n";
+                }
+                writerFailed = true;
+            } else {
+                if (writerFailed && checkpointed) {
+                    cerr << "Journal recovered: all edits are saved again.\n";
+                    writerFailed = false;
+                }
+                if (!writerFailed) {
+                    durableSeq = max(durableSeq, lastSeq);
+                }
+            }
+            itemsDone += items.size();
+            durableCv.notify_all();
+        }
+    }
+};
+
 class Graph {
 public:
     map<int, Camp> camps;
     vector<Edge> edges;
     map<int, vector<pair<int, int>>> adjList;
+    Journal* journal = nullptr; // edits are recorded here once recovery is done
 
     void addCamp(int number, const string& name, const string& address, const string& contact) {
         Camp camp(number, name, address, contact);
         camps[number] = camp;
+        record("camp " + to_string(number) + " " + encode(name) + " " + encode(address) + " " + encode(contact));
+    }
+
+    void setNeedValue(int campNumber, int needValue) {
+        camps[campNumber].needValue = needValue;
+        record("need " + to_string(campNumber) + " " + to_string(needValue));
+    }
+
+    int getNeedValue(int campNumber) const {
+        auto it = camps.find(campNumber);
+        return it != camps.end() ? it->second.needValue : 0;
     }
 
     void addEdge(int src, int dest, int weight = INT32_MAX, bool updateOnly = false) {
         if (camps.find(src) != camps.end() && camps.find(dest) != camps.end()) {
             for (auto& edge : edges) {
                 if (edge.src == src && edge.dest == dest) {
-                    edge.weight = weight;
-                    adjList[src].push_back({dest, weight});
-                    adjList[dest].push_back({src, weight});
+                    setEdgeWeight(src, dest, weight);
+                    recordEdge(src, dest, weight, updateOnly);
                     return;
                 }
             }
@@ -66,6 +420,7 @@ public:
                 edges.push_back(newEdge2);
                 adjList[src].push_back({dest, weight});
                 adjList[dest].push_back({src, weight});
+                recordEdge(src, dest, weight, updateOnly);
             } else {
                 throw std::invalid_argument("Edge does not exist!");
             }
@@ -74,6 +429,26 @@ public:
         }
     }
 
+    // Overwrites both directions of an existing edge, so a cost update
+    // replaces the old weight instead of sitting next to it.
+    void setEdgeWeight(int src, int dest, int weight) {
+        for (auto& edge : edges) {
+            if ((edge.src == src && edge.dest == dest) || (edge.src == dest && edge.dest == src)) {
+                edge.weight = weight;
+            }
+        }
+        for (auto& neighbor : adjList[src]) {
+            if (neighbor.first == dest) {
+                neighbor.second = weight;
+            }
+        }
+        for (auto& neighbor : adjList[dest]) {
+            if (neighbor.first == src) {
+                neighbor.second = weight;
+            }
+        }
+    }
+
     set<int> getNearbyCamps(int campNumber) {
         set<int> nearbyCamps;
         for (auto& edge : edges) {
@@ -158,6 +533,461 @@ public:
 
         return result;
     }
+
+    // Rebuilds the graph from the last checkpoint plus the journal tail, then
+    // starts recording new edits to the journal.
+    void recover(Journal& log) {
+        string snapshot;
+        vector<string> tail;
+        log.recover(snapshot, tail);
+
+        journal = nullptr;
+        if (!snapshot.empty()) {
+            istringstream in(snapshot);
+            readState(in);
+        }
+        for (const string& payload : tail) {
+            applyRecord(payload);
+        }
+        journal = &log;
+        journal->start();
+        if (!tail.empty()) {
+            checkpoint();
+        }
+    }
+
+    void checkpoint() {
+        if (journal) {
+            ostringstream out;
+            writeState(out);
+            journal->checkpoint(out.str());
+        }
+    }
+
+private:
+    void record(const string& payload) {
+        if (journal) {
+            journal->append(payload);
+            if (journal->checkpointDue()) {
+                checkpoint();
+            }
+        }
+    }
+
+    void recordEdge(int src, int dest, int weight, bool updateOnly) {
+        record("edge " + to_string(src) + " " + to_string(dest) + " " + to_string(weight) + " " + to_string(updateOnly));
+    }
+
+    // Strings are stored as <length>:<bytes> so names may contain spaces.
+    static string encode(const string& value) {
+        return to_string(value.size()) + ":" + value;
+    }
+
+    static string decode(istream& in) {
+        size_t length;
+        char colon;
+        if (!(in >> length) || !in.get(colon) || colon != ':') {
+            throw runtime_error("Corrupt journal string");
+        }
+        string value(length, '\0');
+        if (!in.read(&value[0], length)) {
+            throw runtime_error("Corrupt journal string");
+        }
+        return value;
+    }
+
+    void applyRecord(const string& payload) {
+        istringstream in(payload);
+        string op;
+        in >> op;
+        if (op == "camp") {
+            int number;
+            in >> number;
+            string name = decode(in);
+            string address = decode(in);
+            string contact = decode(in);
+            addCamp(number, name, address, contact);
+        } else if (op == "edge") {
+            int src, dest, weight;
+            bool updateOnly;
+            in >> src >> dest >> weight >> updateOnly;
+            addEdge(src, dest, weight, updateOnly);
+        } else if (op == "need") {
+            int campNumber, needValue;
+            in >> campNumber >> needValue;
+            setNeedValue(campNumber, needValue);
+        } else {
+            throw runtime_error("Unknown journal record: " + payload);
+        }
+    }
+
+    // The snapshot holds camps and edges only. adjList is rebuilt from edges
+    // on load, so its size follows the graph, not the number of edits made.
+    void writeState(ostream& out) const {
+        out << "camps " << camps.size() << "\n";
+        for (const auto& camp : camps) {
+            const Camp& c = camp.second;
+            out << camp.first << " " << c.number << " " << c.needValue << " "
+                << encode(c.name) << " " << encode(c.address) << " " << encode(c.contact) << " "
+                << c.resources.size();
+            for (const auto& resource : c.resources) {
+                out << " " << encode(resource.first) << " " << resource.second;
+            }
+            out << "\n";
+        }
+        out << "edges " << edges.size() << "\n";
+        for (const Edge& edge : edges) {
+            out << edge.src << " " << edge.dest << " " << edge.weight << "\n";
+        }
+    }
+
+    void readState(istream& in) {
+        string tag;
+        size_t count;
+        camps.clear();
+        edges.clear();
+        adjList.clear();
+
+        in >> tag >> count;
+        for (size_t i = 0; i < count; i++) {
+            int key;
+            Camp c;
+            size_t resourceCount;
+            in >> key >> c.number >> c.needValue;
+            c.name = decode(in);
+            c.address = decode(in);
+            c.contact = decode(in);
+            in >> resourceCount;
+            for (size_t r = 0; r < resourceCount; r++) {
+                string resource = decode(in);
+                int amount;
+                in >> amount;
+                c.resources.push_back({resource, amount});
+            }
+            camps[key] = c;
+        }
+
+        in >> tag >> count;
+        for (size_t i = 0; i < count; i++) {
+            Edge edge;
+            in >> edge.src >> edge.dest >> edge.weight;
+            edges.push_back(edge);
+            // edges stores both directions, so each one adds its own adjList entry
+            adjList[edge.src].push_back({edge.dest, edge.weight});
+        }
+
+        if (!in) {
+            throw runtime_error("Corrupt checkpoint snapshot");
+        }
+    }
+};
+
+// Camp-to-camp cost matrix for planning convoys. One Dijkstra search per camp
+// runs in parallel over a compact (CSR) copy of the graph, writing straight
+// into a flat row-major matrix. A persistent worker pool does the work, and
+// each thread keeps its own heap between runs.
+// refresh() only recomputes what a few changed edge weights can affect.
+class DistanceMatrix {
+public:
+    static constexpr long long UNREACHABLE = numeric_limits<long long>::max();
+
+    ~DistanceMatrix() {
+        {
+            lock_guard<mutex> lock(poolMutex);
+            stopping = true;
+        }
+        poolCv.notify_all();
+        for (thread& t : pool) {
+            t.join();
+        }
+    }
+
+    // Brings the matrix in line with the graph. A change in the set of camps
+    // rebuilds everything; otherwise only the edited edges are applied.
+    void refresh(const Graph& graph) {
+        vector<int> numbers;
+        for (const auto& camp : graph.camps) {
+            numbers.push_back(camp.first);
+        }
+        if (numbers != campNumbers) {
+            campNumbers = numbers;
+            indexOf.clear();
+            for (size_t i = 0; i < campNumbers.size(); i++) {
+                indexOf[campNumbers[i]] = i;
+            }
+            edgeWeights = collectEdges(graph);
+            rebuild();
+            return;
+        }
+
+        map<pair<int, int>, long long> current = collectEdges(graph);
+        vector<pair<pair<int, int>, long long>> lowered;
+        vector<pair<pair<int, int>, long long>> raised; // holds the old weight
+        for (const auto& edge : current) {
+            auto old = edgeWeights.find(edge.first);
+            if (old == edgeWeights.end() || edge.second < old->second) {
+                lowered.push_back(edge);
+            } else if (edge.second > old->second) {
+                raised.push_back(*old);
+            }
+        }
+        for (const auto& edge : edgeWeights) {
+            if (current.find(edge.first) == current.end()) {
+                raised.push_back(edge);
+            }
+        }
+        if (lowered.empty() && raised.empty()) {
+            return;
+        }
+
+        edgeWeights = current;
+        size_t n = campNumbers.size();
+        if (lowered.size() + raised.size() > max<size_t>(4, n / 16)) {
+            rebuild();
+            return;
+        }
+        buildAdjacency();
+
+        // A cheaper edge can only shorten paths through it, which is an O(n^2)
+        // pass per edge instead of n searches.
+        for (const auto& edge : lowered) {
+            lowerEdge(edge.first.first, edge.first.second, edge.second);
+        }
+
+        // A dearer edge only matters to rows whose shortest paths used it.
+        vector<int> affected;
+        for (size_t s = 0; s < n; s++) {
+            const long long* row = &dist[s * n];
+            for (const auto& edge : raised) {
+                long long du = row[edge.first.first];
+                long long dv = row[edge.first.second];
+                if ((du != UNREACHABLE && du + edge.second == dv) || (dv != UNREACHABLE && dv + edge.second == du)) {
+                    affected.push_back(s);
+                    break;
+                }
+            }
+        }
+        runSearches(affected);
+    }
+
+    const vector<int>& camps() const {
+        return campNumbers;
+    }
+
+    long long distance(int srcCamp, int destCamp) const {
+        auto src = indexOf.find(srcCamp);
+        auto dest = indexOf.find(destCamp);
+        if (src == indexOf.end() || dest == indexOf.end()) {
+            throw std::invalid_argument("One or both camp numbers are invalid!");
+        }
+        return dist[src->second * campNumbers.size() + dest->second];
+    }
+
+private:
+    struct Workspace {
+        vector<pair<long long, int>> heap;
+    };
+
+    vector<int> campNumbers;
+    map<int, int> indexOf;
+    map<pair<int, int>, long long> edgeWeights; // (lower index, higher index) -> cheapest weight
+    vector<int> offsets;
+    vector<int> targets;
+    vector<long long> weights;
+    vector<long long> dist;
+    vector<Workspace> workspaces; // one per pool thread, index 0 is the caller's
+
+    // Worker pool, started on the first refresh and kept for the matrix's lifetime.
+    vector<thread> pool;
+    mutex poolMutex;
+    condition_variable poolCv;
+    condition_variable doneCv;
+    const function<void(size_t, Workspace&)>* job = nullptr;
+    size_t jobCount = 0;
+    atomic<size_t> nextItem{0};
+    size_t generation = 0;
+    size_t busyWorkers = 0;
+    bool stopping = false;
+
+    // Self-loops are skipped, and if a pair somehow has several entries the
+    // cheapest is kept, as a search would take it.
+    map<pair<int, int>, long long> collectEdges(const Graph& graph) const {
+        map<pair<int, int>, long long> result;
+        for (const auto& entry : graph.adjList) {
+            auto src = indexOf.find(entry.first);
+            if (src == indexOf.end()) {
+                continue;
+            }
+            for (const auto& neighbor : entry.second) {
+                auto dest = indexOf.find(neighbor.first);
+                if (dest == indexOf.end() || dest->second == src->second) {
+                    continue;
+                }
+                pair<int, int> key = minmax(src->second, dest->second);
+                auto it = result.find(key);
+                if (it == result.end() || neighbor.second < it->second) {
+                    result[key] = neighbor.second;
+                }
+            }
+        }
+        return result;
+    }
+
+    void buildAdjacency() {
+        size_t n = campNumbers.size();
+        offsets.assign(n + 1, 0);
+        for (const auto& edge : edgeWeights) {
+            offsets[edge.first.first + 1]++;
+            offsets[edge.first.second + 1]++;
+        }
+        for (size_t i = 0; i < n; i++) {
+            offsets[i + 1] += offsets[i];
+        }
+        targets.resize(offsets[n]);
+        weights.resize(offsets[n]);
+        vector<int> fill(offsets.begin(), offsets.end() - 1);
+        for (const auto& edge : edgeWeights) {
+            int u = edge.first.first;
+            int v = edge.first.second;
+            targets[fill[u]] = v;
+            weights[fill[u]++] = edge.second;
+            targets[fill[v]] = u;
+            weights[fill[v]++] = edge.second;
+        }
+    }
+
+    void rebuild() {
+        size_t n = campNumbers.size();
+        buildAdjacency();
+        dist.assign(n * n, UNREACHABLE);
+        vector<int> sources(n);
+        for (size_t i = 0; i < n; i++) {
+            sources[i] = i;
+        }
+        runSearches(sources);
+    }
+
+    // Small jobs run serially: below this much work, waking the pool costs more
+    // than it saves.
+    static const size_t PARALLEL_WORK_CUTOFF = 1 << 16;
+
+    // Hands out items to the pool plus the calling thread; each thread sticks
+    // to its own workspace. work is a rough count of inner-loop steps.
+    void parallelFor(size_t count, size_t work, const function<void(size_t, Workspace&)>& fn) {
+        if (count == 0) {
+            return;
+        }
+        startPool();
+        if (pool.empty() || count == 1 || work < PARALLEL_WORK_CUTOFF) {
+            for (size_t i = 0; i < count; i++) {
+                fn(i, workspaces[0]);
+            }
+            return;
+        }
+        {
+            lock_guard<mutex> lock(poolMutex);
+            job = &fn;
+            jobCount = count;
+            nextItem = 0;
+            busyWorkers = pool.size();
+            generation++;
+        }
+        poolCv.notify_all();
+        runJob(workspaces[0]);
+        unique_lock<mutex> lock(poolMutex);
+        doneCv.wait(lock, [&] { return busyWorkers == 0; });
+        job = nullptr;
+    }
+
+    void startPool() {
+        if (!workspaces.empty()) {
+            return;
+        }
+        size_t threads = max(1u, thread::hardware_concurrency());
+        workspaces.resize(threads);
+        for (size_t t = 1; t < threads; t++) {
+            pool.emplace_back(&DistanceMatrix::workerLoop, this, t);
+        }
+    }
+
+    void runJob(Workspace& ws) {
+        for (size_t i = nextItem++; i < jobCount; i = nextItem++) {
+            (*job)(i, ws);
+        }
+    }
+
+    void workerLoop(size_t id) {
+        size_t seen = 0;
+        unique_lock<mutex> lock(poolMutex);
+        while (true) {
+            poolCv.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            lock.unlock();
+            runJob(workspaces[id]);
+            lock.lock();
+            if (--busyWorkers == 0) {
+                doneCv.notify_one();
+            }
+        }
+    }
+
+    void runSearches(const vector<int>& sources) {
+        size_t work = sources.size() * (campNumbers.size() + targets.size());
+        parallelFor(sources.size(), work, [&](size_t i, Workspace& ws) {
+            search(sources[i], ws);
+        });
+    }
+
+    void search(int source, Workspace& ws) {
+        size_t n = campNumbers.size();
+        long long* row = &dist[source * n];
+        fill(row, row + n, UNREACHABLE);
+        row[source] = 0;
+
+        auto later = greater<pair<long long, int>>();
+        vector<pair<long long, int>>& heap = ws.heap;
+        heap.clear();
+        heap.push_back({0, source});
+        while (!heap.empty()) {
+            pop_heap(heap.begin(), heap.end(), later);
+            long long d = heap.back().first;
+            int node = heap.back().second;
+            heap.pop_back();
+            if (d > row[node]) continue;
+
+            for (int e = offsets[node]; e < offsets[node + 1]; e++) {
+                long long candidate = d + weights[e];
+                if (candidate < row[targets[e]]) {
+                    row[targets[e]] = candidate;
+                    heap.push_back({candidate, targets[e]});
+                    push_heap(heap.begin(), heap.end(), later);
+                }
+            }
+        }
+    }
+
+    void lowerEdge(int u, int v, long long weight) {
+        size_t n = campNumbers.size();
+        // Rows u and v are read by every row, so work from copies of them.
+        vector<long long> fromU(dist.begin() + u * n, dist.begin() + (u + 1) * n);
+        vector<long long> fromV(dist.begin() + v * n, dist.begin() + (v + 1) * n);
+        parallelFor(n, n * n, [&](size_t s, Workspace&) {
+            long long* row = &dist[s * n];
+            long long toU = row[u];
+            long long toV = row[v];
+            for (size_t x = 0; x < n; x++) {
+                if (toU != UNREACHABLE && fromV[x] != UNREACHABLE) {
+                    row[x] = min(row[x], toU + weight + fromV[x]);
+                }
+                if (toV != UNREACHABLE && fromU[x] != UNREACHABLE) {
+                    row[x] = min(row[x], toV + weight + fromU[x]);
+                }
+            }
+        });
+    }
 };
 
 void addHardcodedNodesAndEdges(Graph& graph) {
@@ -179,6 +1009,14 @@ void addHardcodedNodesAndEdges(Graph& graph) {
 
 int main() {
     Graph graph;
+    DistanceMatrix distanceMatrix;
+    Journal journal("camps.journal", "camps.checkpoint");
+    try {
+        graph.recover(journal);
+    } catch (const exception& e) {
+        cout << "Recovery failed: " << e.what() << '\n';
+        return 1;
+    }
     int role;
     do {
         cout << "Select your role:\n";
@@ -201,7 +1039,8 @@ int main() {
                         cout << "1) Add a camp\n";
                         cout << "2) View\n";
                         cout << "3) Add edges\n";
-                        cout << "4) Exit\n";
+                        cout << "4) Camp distance matrix\n";
+                        cout << "5) Exit\n";
                         cout << "Enter your choice: ";
                         cin >> choice;
 
@@ -253,14 +1092,38 @@ int main() {
                                 }
                                 break;
                             }
-                            case 4:
+                            case 4: {
+                                distanceMatrix.refresh(graph);
+                                const vector<int>& campNumbers = distanceMatrix.camps();
+                                cout << "Camp distance matrix:\n";
+                                cout << "From\\To";
+                                for (int dest : campNumbers) {
+                                    cout << "\t" << dest;
+                                }
+                                cout << "\n";
+                                for (int src : campNumbers) {
+                                    cout << src;
+                                    for (int dest : campNumbers) {
+                                        long long cost = distanceMatrix.distance(src, dest);
+                                        cout << "\t";
+                                        if (cost == DistanceMatrix::UNREACHABLE) {
+                                            cout << "-";
+                                        } else {
+                                            cout << cost;
+                                        }
+                                    }
+                                    cout << "\n";
+                                }
+                                break;
+                            }
+                            case 5:
                                 cout << "Exiting Admin...\n";
                                 break;
                             default:
                                 cout << "Invalid choice!\n";
                                 break;
                         }
-                    } while (choice != 4);
+                    } while (choice != 5);
                 } else {
                     cout << "Invalid password!\n";
                 }
@@ -317,8 +1180,8 @@ int main() {
                                     int distanceFactor = 10;
 
                                      // Get the need values of the source and destination camps
-                                    int srcNeedValue = graph.camps[srcCampNumber].needValue;
-                                    int destNeedValue = graph.camps[destCampNumber].needValue;
+                                    int srcNeedValue = graph.getNeedValue(srcCampNumber);
+                                    int destNeedValue = graph.getNeedValue(destCampNumber);
 
                                     // Calculate the average need value
                                     int averageNeedValue = (srcNeedValue + destNeedValue) / 2.0;
@@ -334,7 +1197,7 @@ int main() {
                             case 3: {
                                 cout << "Enter the need value: ";
                                 cin >> needValue;
-                                graph.camps[campNumber].needValue = needValue;
+                                graph.setNeedValue(campNumber, needValue);
                                 break;
                             }
                             case 4:
@@ -357,13 +1220,17 @@ int main() {
                 cin >> password;
                 if (password == "user_password") {
                     // User menu
-                    addHardcodedNodesAndEdges(graph);
+                    // The user location and routing nodes are scratch data for this
+                    // lookup only, so they go on an unjournaled copy of the graph.
+                    Graph userGraph = graph;
+                    userGraph.journal = nullptr;
+                    addHardcodedNodesAndEdges(userGraph);
                     int userNode = 1001;
-                    vector<int> distances = graph.dijkstra(userNode);
+                    vector<int> distances = userGraph.dijkstra(userNode);
                     int minDistance = numeric_limits<int>::max();
                     int nearestCamp = -1;
 
-                    for (const auto& camp : graph.camps) {
+                    for (const auto& camp : userGraph.camps) {
                         if (camp.first != userNode && distances[camp.first] < minDistance) {
                             minDistance = distances[camp.first];
                             nearestCamp = camp.first;
@@ -371,7 +1238,7 @@ int main() {
                     }
 
                     if (nearestCamp != -1) {
-                        Camp& nearest = graph.camps[nearestCamp];
+                        Camp& nearest = userGraph.camps[nearestCamp];
                         cout << "The nearest camp is:\n";
                         cout << "Camp number: " << nearest.number << "\n";
                         cout << "Camp name: " << nearest.name << "\n";
@@ -386,6 +1253,10 @@ int main() {
                 break;
             }
             case 4:
+                graph.checkpoint();
+                if (!journal.sync()) {
+                    cout << "Warning: some edits could not be saved!\n";
+                }
                 cout << "Exiting ...\n";
                 break;
             default: {